@@ -1,6 +1,8 @@
 #ifndef SQLITEMM_SQLITEMM_DB_HPP_
 #define SQLITEMM_SQLITEMM_DB_HPP_
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <functional>
@@ -15,11 +17,25 @@ namespace sqlitemm {
 
 /* include/sqlitemm/stmt.hpp */
 class Stmt;
+/* include/sqlitemm/transaction.hpp */
+class Transaction;
+class Savepoint;
 
 class DB {
   friend class Stmt;
+  friend class Transaction;
+  friend class Savepoint;
 
 public:
+  // how `DB::deserialize` treats the database image
+  // READONLY: sqlite reads the image in place (no copy), writes fail with
+  //   `SQLITE_READONLY`, the image must outlive the `DB`
+  // RESIZEABLE: the image is copied once into sqlite-owned memory, which
+  //   grows as needed, the caller's image may be released right away
+  enum class DeserializeMode : std::uint8_t { READONLY, RESIZEABLE };
+  // doc: https://www.sqlite.org/lang_transaction.html
+  enum class TransactionMode : std::uint8_t { DEFERRED, IMMEDIATE, EXCLUSIVE };
+
   // create a private, temporary in-memory database
   DB();
   // open database `file`, or create a private temporary on-disk database
@@ -53,12 +69,86 @@ public:
   // if the db is in autocommit mode
   [[nodiscard]] bool autocommit();
 
+  // begin a transaction, which is rolled back when the returned
+  // `Transaction` is destroyed without `Transaction::commit`
+  [[nodiscard]] Transaction transaction(TransactionMode mode = TransactionMode::DEFERRED);
+  // open a savepoint nested in the innermost one, which is rolled back when
+  // the returned `Savepoint` is destroyed without `Savepoint::release`
+  // guards only track transactions and savepoints they began themselves,
+  // do not mix them with BEGIN/SAVEPOINT statements passed to `exec`
+  // doc: https://www.sqlite.org/lang_savepoint.html
+  [[nodiscard]] Savepoint savepoint();
+
+  // return the image of database `schema` ("main", "temp" or an attached
+  // name), the same bytes as the on-disk file would contain
+  // databases created by `DB::deserialize` are copied once, others twice
+  // (sqlite builds the image, which is then copied into the `Value::Blob`)
+  // doc: https://www.sqlite.org/c3ref/serialize.html
+  [[nodiscard]] Value::Blob serialize(const std::string& schema = "main");
+
+  // create an in-memory database over the image `data` of `size` bytes
+  // a WAL-mode image (header bytes 18/19 equal to 2) is refused in READONLY
+  // mode, in RESIZEABLE mode the copy is switched to rollback-journal mode,
+  // the image must be checkpointed, the `-wal` file is not read
+  // an empty image gives an empty database
+  // on failure the returned `DB` is closed
+  // doc: https://www.sqlite.org/c3ref/deserialize.html
+  [[nodiscard]] static DB deserialize(const std::uint8_t* data,
+                                      std::size_t size,
+                                      DeserializeMode mode = DeserializeMode::READONLY);
+  [[nodiscard]] static DB deserialize(const Value::Blob& image, DeserializeMode mode = DeserializeMode::READONLY);
+  // the `DB` keeps `image` until it is closed, so the result of `serialize`
+  // can be passed directly
+  [[nodiscard]] static DB deserialize(Value::Blob&& image, DeserializeMode mode = DeserializeMode::READONLY);
+  // create an in-memory database over the memory-mapped image `file`
+  // in READONLY mode the mapping is shared, so processes opening the same
+  // `file` share its pages, it is unmapped when the `DB` is closed
+  // sqlite reads pages straight from the mapping: while it is mapped, the
+  // file must not be modified (readers see torn pages) or truncated (reads
+  // raise SIGBUS), write a new snapshot to another file and `rename` it over
+  // `file` instead, which leaves the mapped file intact
+  [[nodiscard]] static DB deserialize(const std::filesystem::path& file,
+                                      DeserializeMode mode = DeserializeMode::READONLY);
+
 protected:
   void* sqlite3_ptr_{nullptr};
   std::unordered_set<Stmt*> stmt_ptrs_;
   std::filesystem::path db_file_;
+  // the read-only mapping of the image given to `DB::deserialize`
+  void* mmap_ptr_{nullptr};
+  std::size_t mmap_size_{0};
+  // the image moved into `DB::deserialize`
+  Value::Blob image_;
+  // sqlite3_stmt of BEGIN/COMMIT/ROLLBACK, prepared on first use and kept
+  // until `close`, indexed by `Control`
+  enum Control : std::uint8_t { BEGIN_DEFERRED, BEGIN_IMMEDIATE, BEGIN_EXCLUSIVE, COMMIT, ROLLBACK, CONTROL_COUNT };
+  std::array<void*, CONTROL_COUNT> control_stmts_{};
+  // sqlite3_stmt of SAVEPOINT/RELEASE/ROLLBACK TO for every nesting level
+  enum SavepointControl : std::uint8_t { SAVEPOINT, RELEASE, ROLLBACK_TO, SAVEPOINT_CONTROL_COUNT };
+  std::vector<std::array<void*, SAVEPOINT_CONTROL_COUNT>> savepoint_stmts_;
+  // bumped by every BEGIN and SAVEPOINT, so guards can tell their own
+  // transaction or savepoint from a later one
+  std::uint64_t generation_{0};
+  // generation of the transaction begun by the last guard
+  std::uint64_t transaction_generation_{0};
+  // generations of the savepoints opened by guards, innermost last
+  std::vector<std::uint64_t> savepoint_generations_;
+  // live guards, detached by `close` and moved along with the `DB`
+  std::unordered_set<Transaction*> transaction_ptrs_;
+  std::unordered_set<Savepoint*> savepoint_ptrs_;
 
   void open();
+  // run `control` with a cached statement
+  bool exec_control(Control control);
+  bool exec_savepoint_control(std::size_t depth, SavepointControl control);
+  bool exec_cached(void** stmt_ptr, const std::string& statement);
+  void finalize_controls();
+  // point the live guards at this `DB`
+  void adopt_guards();
+  void detach_guards();
+  // hand `data` to sqlite as the content of the main database
+  bool load_image(const std::uint8_t* data, std::size_t size, DeserializeMode mode);
+  void unmap();
 };
 
 const char* sqlite_version();
@@ -0,0 +1,70 @@
+#ifndef SQLITEMM_SQLITEMM_ROW_BATCH_HPP_
+#define SQLITEMM_SQLITEMM_ROW_BATCH_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "sqlitemm/value.hpp"
+
+namespace sqlitemm {
+
+/* include/sqlitemm/stmt.hpp */
+class Stmt;
+
+// a batch of result rows filled by `Stmt::each_batch`
+// cells are stored row by row in one array, TEXT and BLOB bytes are copied
+// into one arena, both keep their capacity when the batch is refilled
+// accessors do not check `row` and `column`, text and blob views are valid
+// until the batch is refilled
+class RowBatch {
+public:
+  friend class Stmt;
+
+  struct Cell {
+    Value::Type type{Value::Type::NUL};
+    union {
+      Value::Integer integer{0};
+      Value::Float real;
+      // TEXT and BLOB: position in the arena
+      std::size_t offset;
+    };
+    // TEXT and BLOB: number of bytes
+    std::size_t bytes{0};
+  };
+
+  RowBatch() = default;
+
+  // number of rows
+  [[nodiscard]] std::size_t size() const;
+  [[nodiscard]] bool empty() const;
+  [[nodiscard]] int column_count() const;
+
+  [[nodiscard]] const Cell& cell(std::size_t row, int column) const;
+  [[nodiscard]] Value::Type type(std::size_t row, int column) const;
+  [[nodiscard]] Value::Integer integer(std::size_t row, int column) const;
+  [[nodiscard]] Value::Float real(std::size_t row, int column) const;
+  [[nodiscard]] std::string_view text(std::size_t row, int column) const;
+  [[nodiscard]] const std::uint8_t* blob(std::size_t row, int column) const;
+  // number of bytes of a TEXT or BLOB cell
+  [[nodiscard]] std::size_t bytes(std::size_t row, int column) const;
+  // copy the cell into a `Value`
+  [[nodiscard]] Value value(std::size_t row, int column) const;
+
+protected:
+  std::vector<Cell> cells_;
+  std::string arena_;
+  int column_count_{0};
+
+  // drop all rows, keeping the capacity
+  void clear(int column_count);
+  void reserve(std::size_t rows);
+  // copy the current row of sqlite3_stmt `stmt`
+  void append_row(void* stmt);
+};
+
+} // namespace sqlitemm
+
+#endif // SQLITEMM_SQLITEMM_ROW_BATCH_HPP_
@@ -1,12 +1,14 @@
 #ifndef SQLITEMM_SQLITEMM_STMT_HPP_
 #define SQLITEMM_SQLITEMM_STMT_HPP_
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "sqlitemm/row_batch.hpp"
 #include "sqlitemm/value.hpp"
 
 namespace sqlitemm {
@@ -37,6 +39,10 @@ public:
   Stmt& each_row(const std::function<void(const std::vector<std::string>&, const std::vector<Value>&)>& callback);
   Stmt& each_row(const std::function<void(const std::vector<Value>&)>& callback);
   Stmt& each_row();
+  // call `callback` with up to `batch_size` rows at a time, the `RowBatch` is
+  // owned by the `Stmt` and reused by every batch and execution
+  // pass `SIZE_MAX` to get all rows in one batch
+  Stmt& each_batch(std::size_t batch_size, const std::function<void(const RowBatch&)>& callback);
   [[nodiscard]] std::int64_t changes();
   [[nodiscard]] std::string column_name(int column_index);
   [[nodiscard]] std::vector<std::string> column_names();
@@ -47,6 +53,7 @@ protected:
 
   void* sqlite3_stmt_ptr_{nullptr};
   DB* db_ptr_{nullptr};
+  RowBatch batch_;
 };
 
 } // namespace sqlitemm
@@ -0,0 +1,81 @@
+#ifndef SQLITEMM_SQLITEMM_TRANSACTION_HPP_
+#define SQLITEMM_SQLITEMM_TRANSACTION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "sqlitemm/db.hpp"
+
+namespace sqlitemm {
+
+// a transaction guard, created by `DB::transaction`
+// the transaction is rolled back on destruction unless it was committed
+class Transaction {
+public:
+  friend class DB;
+
+  Transaction() = delete;
+  Transaction(const Transaction&) = delete;
+  Transaction(Transaction&& transaction_old) noexcept;
+  Transaction& operator=(const Transaction&) = delete;
+  Transaction& operator=(Transaction&&) = delete;
+
+  virtual ~Transaction();
+
+  // return false if the transaction is still open, e.g. on `SQLITE_BUSY`,
+  // in which case `commit` may be retried
+  bool commit();
+  bool rollback();
+  // if the transaction was begun and is not finished yet
+  [[nodiscard]] bool active();
+
+protected:
+  explicit Transaction(DB* db, DB::TransactionMode mode);
+
+  DB* db_ptr_{nullptr};
+  // `DB::generation_` at BEGIN
+  std::uint64_t generation_{0};
+
+  // stop tracking the transaction
+  void detach();
+};
+
+// a savepoint guard, created by `DB::savepoint`
+// the savepoint is rolled back and released on destruction unless it was
+// released, savepoints are expected to be finished innermost first
+class Savepoint {
+public:
+  friend class DB;
+
+  Savepoint() = delete;
+  Savepoint(const Savepoint&) = delete;
+  Savepoint(Savepoint&& savepoint_old) noexcept;
+  Savepoint& operator=(const Savepoint&) = delete;
+  Savepoint& operator=(Savepoint&&) = delete;
+
+  virtual ~Savepoint();
+
+  // merge the changes into the enclosing savepoint or transaction, or
+  // commit them if there is none
+  bool release();
+  // undo the changes made since the savepoint and release it
+  bool rollback();
+  // if the savepoint was opened and is not finished yet
+  [[nodiscard]] bool active();
+
+protected:
+  explicit Savepoint(DB* db);
+
+  DB* db_ptr_{nullptr};
+  // nesting level, 0 for the outermost savepoint
+  std::size_t depth_{0};
+  // `DB::generation_` at SAVEPOINT
+  std::uint64_t generation_{0};
+
+  // stop tracking the savepoint
+  void detach();
+};
+
+} // namespace sqlitemm
+
+#endif // SQLITEMM_SQLITEMM_TRANSACTION_HPP_
@@ -1,16 +1,26 @@
 #include "sqlitemm/db.hpp"
 
+#include <array>
+#include <cerrno>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "sqlite3.h"
 
 #include "sqlitemm/stmt.hpp"
+#include "sqlitemm/transaction.hpp"
 #include "sqlitemm/value.hpp"
 
 namespace sqlitemm {
@@ -26,15 +36,56 @@ DB::DB(const std::filesystem::path& file) : db_file_(file) {
 DB::DB(DB&& db_old) noexcept
   : sqlite3_ptr_{db_old.sqlite3_ptr_}
   , stmt_ptrs_{std::move(db_old.stmt_ptrs_)}
-  , db_file_{std::move(db_old.db_file_)} {
+  , db_file_{std::move(db_old.db_file_)}
+  , mmap_ptr_{db_old.mmap_ptr_}
+  , mmap_size_{db_old.mmap_size_}
+  , image_{std::move(db_old.image_)}
+  , control_stmts_{db_old.control_stmts_}
+  , savepoint_stmts_{std::move(db_old.savepoint_stmts_)}
+  , generation_{db_old.generation_}
+  , transaction_generation_{db_old.transaction_generation_}
+  , savepoint_generations_{std::move(db_old.savepoint_generations_)}
+  , transaction_ptrs_{std::move(db_old.transaction_ptrs_)}
+  , savepoint_ptrs_{std::move(db_old.savepoint_ptrs_)} {
   db_old.sqlite3_ptr_ = nullptr;
+  db_old.mmap_ptr_ = nullptr;
+  db_old.mmap_size_ = 0;
+  db_old.control_stmts_ = {};
+  db_old.savepoint_stmts_.clear();
+  db_old.savepoint_generations_.clear();
+  db_old.transaction_ptrs_.clear();
+  db_old.savepoint_ptrs_.clear();
+  adopt_guards();
 }
 
 DB& DB::operator=(DB&& db_old) noexcept {
+  if (this == &db_old) {
+    return *this;
+  }
+  // release the connection, statements and mapping held so far
+  close();
   sqlite3_ptr_ = db_old.sqlite3_ptr_;
   db_old.sqlite3_ptr_ = nullptr;
   stmt_ptrs_ = std::move(db_old.stmt_ptrs_);
   db_file_ = std::move(db_old.db_file_);
+  mmap_ptr_ = db_old.mmap_ptr_;
+  mmap_size_ = db_old.mmap_size_;
+  db_old.mmap_ptr_ = nullptr;
+  db_old.mmap_size_ = 0;
+  image_ = std::move(db_old.image_);
+  control_stmts_ = db_old.control_stmts_;
+  savepoint_stmts_ = std::move(db_old.savepoint_stmts_);
+  generation_ = db_old.generation_;
+  transaction_generation_ = db_old.transaction_generation_;
+  savepoint_generations_ = std::move(db_old.savepoint_generations_);
+  transaction_ptrs_ = std::move(db_old.transaction_ptrs_);
+  savepoint_ptrs_ = std::move(db_old.savepoint_ptrs_);
+  db_old.control_stmts_ = {};
+  db_old.savepoint_stmts_.clear();
+  db_old.savepoint_generations_.clear();
+  db_old.transaction_ptrs_.clear();
+  db_old.savepoint_ptrs_.clear();
+  adopt_guards();
   return *this;
 }
 
@@ -47,6 +98,8 @@ void DB::close() {
   for (Stmt* stmt : stmt_ptrs_) {
     stmt->close();
   }
+  detach_guards();
+  finalize_controls();
   // close connection
   int ret = sqlite3_close(reinterpret_cast<sqlite3*>(sqlite3_ptr_));
   if (ret != SQLITE_OK) {
@@ -54,6 +107,11 @@ void DB::close() {
                                "failed to close database (may cause memory leak): %s\n",
                                sqlite3_errmsg(reinterpret_cast<sqlite3*>(sqlite3_ptr_)));
   }
+  if (ret == SQLITE_OK) {
+    // the image must stay mapped and owned until the connection is gone
+    unmap();
+    image_ = {};
+  }
   sqlite3_ptr_ = nullptr;
 }
 
@@ -98,10 +156,119 @@ DB& DB::exec(std::string_view statement) {
   return sqlite3_get_autocommit(reinterpret_cast<sqlite3*>(sqlite3_ptr_)) != 0;
 }
 
+[[nodiscard]] Transaction DB::transaction(TransactionMode mode) {
+  return Transaction(this, mode);
+}
+
+[[nodiscard]] Savepoint DB::savepoint() {
+  return Savepoint(this);
+}
+
 [[nodiscard]] std::int64_t DB::total_changes() {
   return sqlite3_total_changes64(reinterpret_cast<sqlite3*>(sqlite3_ptr_));
 }
 
+[[nodiscard]] Value::Blob DB::serialize(const std::string& schema) {
+  sqlite3* db = reinterpret_cast<sqlite3*>(sqlite3_ptr_);
+  if (db == nullptr) {
+    // already closed
+    return {};
+  }
+  sqlite3_int64 size = 0;
+  // databases created by `DB::deserialize` already hold a contiguous image,
+  // try to read it in place before letting sqlite build a copy
+  const unsigned char* data = sqlite3_serialize(db, schema.c_str(), &size, SQLITE_SERIALIZE_NOCOPY);
+  if (data != nullptr) {
+    return Value::Blob{data, data + size};
+  }
+  unsigned char* copy = sqlite3_serialize(db, schema.c_str(), &size, 0);
+  if (copy == nullptr) {
+    if (size == 0) {
+      // empty database
+      return {};
+    }
+    std::ignore = std::fprintf(stderr,
+                               "failed to serialize database `%s`: %s\n",
+                               schema.c_str(),
+                               sqlite3_errcode(db) == SQLITE_OK ? "no such database" : sqlite3_errmsg(db));
+    return {};
+  }
+  Value::Blob image{copy, copy + size};
+  sqlite3_free(copy);
+  return image;
+}
+
+[[nodiscard]] DB DB::deserialize(const std::uint8_t* data, std::size_t size, DeserializeMode mode) {
+  DB db;
+  if (!db.load_image(data, size, mode)) {
+    db.close();
+  }
+  return db;
+}
+
+[[nodiscard]] DB DB::deserialize(const Value::Blob& image, DeserializeMode mode) {
+  return deserialize(image.data(), image.size(), mode);
+}
+
+[[nodiscard]] DB DB::deserialize(Value::Blob&& image, DeserializeMode mode) {
+  DB db;
+  if (!db.load_image(image.data(), image.size(), mode)) {
+    db.close();
+    return db;
+  }
+  if (mode == DeserializeMode::READONLY) {
+    // sqlite reads the image in place, moving it keeps the buffer
+    db.image_ = std::move(image);
+  }
+  return db;
+}
+
+[[nodiscard]] DB DB::deserialize(const std::filesystem::path& file, DeserializeMode mode) {
+  DB db;
+  int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    std::ignore = std::fprintf(stderr, "failed to open database image `%s`: %s\n", file.c_str(), std::strerror(errno));
+    db.close();
+    return db;
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    std::ignore = std::fprintf(stderr, "failed to map database image `%s`: %s\n", file.c_str(), std::strerror(errno));
+    ::close(fd);
+    db.close();
+    return db;
+  }
+  const auto size = static_cast<std::size_t>(st.st_size);
+  if (size == 0) {
+    // nothing to map, an empty image is an empty database
+    ::close(fd);
+    if (!db.load_image(nullptr, 0, mode)) {
+      db.close();
+    }
+    return db;
+  }
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping keeps its own reference to the file
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    std::ignore = std::fprintf(stderr, "failed to map database image `%s`: %s\n", file.c_str(), std::strerror(errno));
+    db.close();
+    return db;
+  }
+  db.mmap_ptr_ = data;
+  db.mmap_size_ = size;
+  if (!db.load_image(reinterpret_cast<const std::uint8_t*>(data), size, mode)) {
+    // also unmaps `data`
+    db.close();
+    return db;
+  }
+  if (mode == DeserializeMode::RESIZEABLE) {
+    // sqlite owns a copy now
+    db.unmap();
+  }
+  return db;
+}
+
 void DB::open() {
   // close the previous connection
   if (sqlite3_ptr_ != nullptr) {
@@ -120,6 +287,152 @@ void DB::open() {
   }
 }
 
+bool DB::load_image(const std::uint8_t* data, std::size_t size, DeserializeMode mode) {
+  sqlite3* db = reinterpret_cast<sqlite3*>(sqlite3_ptr_);
+  if (db == nullptr) {
+    return false;
+  }
+  unsigned char* image = nullptr;
+  unsigned int flags = 0;
+  // bytes 18 and 19 of the header are the file format write/read versions,
+  // 2 means WAL, which needs shared memory the in-memory backend lacks
+  // doc: https://www.sqlite.org/fileformat2.html#database_header
+  const bool wal = size >= 20 && (data[18] == 2 || data[19] == 2);
+  if (mode == DeserializeMode::READONLY) {
+    if (wal) {
+      std::ignore = std::fprintf(stderr,
+                                 "failed to deserialize database: the image is in WAL mode, switch it to "
+                                 "`PRAGMA journal_mode = DELETE` first or use DeserializeMode::RESIZEABLE\n");
+      return false;
+    }
+    // sqlite never writes to a read-only image, so it can be used in place
+    image = const_cast<unsigned char*>(data);
+    flags = SQLITE_DESERIALIZE_READONLY;
+  } else {
+    // a resizeable image must come from `sqlite3_malloc64`, an empty one
+    // starts as NULL and is allocated as the database grows
+    if (size != 0) {
+      image = reinterpret_cast<unsigned char*>(sqlite3_malloc64(size));
+      if (image == nullptr) {
+        std::ignore = std::fprintf(stderr, "failed to deserialize database: out of memory\n");
+        return false;
+      }
+      std::memcpy(image, data, size);
+    }
+    if (wal) {
+      // the copy is private, read it as a rollback-journal database
+      image[18] = 1;
+      image[19] = 1;
+    }
+    flags = SQLITE_DESERIALIZE_RESIZEABLE | SQLITE_DESERIALIZE_FREEONCLOSE;
+  }
+  // with FREEONCLOSE, sqlite frees `image` even if this fails
+  int ret = sqlite3_deserialize(db,
+                                "main",
+                                image,
+                                static_cast<sqlite3_int64>(size),
+                                static_cast<sqlite3_int64>(size),
+                                flags);
+  if (ret != SQLITE_OK) {
+    std::ignore = std::fprintf(stderr, "failed to deserialize database: %s\n", sqlite3_errmsg(db));
+    return false;
+  }
+  if (mode == DeserializeMode::READONLY) {
+    // let the pager read pages straight from the image instead of copying
+    // them into its cache
+    exec("PRAGMA main.mmap_size = " + std::to_string(size) + ";");
+  }
+  return true;
+}
+
+bool DB::exec_control(Control control) {
+  static const std::array<const char*, CONTROL_COUNT> statements{
+    "BEGIN DEFERRED;", "BEGIN IMMEDIATE;", "BEGIN EXCLUSIVE;", "COMMIT;", "ROLLBACK;"};
+  return exec_cached(&control_stmts_[control], statements[control]);
+}
+
+bool DB::exec_savepoint_control(std::size_t depth, SavepointControl control) {
+  static const std::array<const char*, SAVEPOINT_CONTROL_COUNT> statements{"SAVEPOINT", "RELEASE", "ROLLBACK TO"};
+  if (savepoint_stmts_.size() <= depth) {
+    savepoint_stmts_.resize(depth + 1);
+  }
+  return exec_cached(&savepoint_stmts_[depth][control],
+                     std::string{statements[control]} + " sqlitemm_savepoint_" + std::to_string(depth) + ";");
+}
+
+bool DB::exec_cached(void** stmt_ptr, const std::string& statement) {
+  sqlite3* db = reinterpret_cast<sqlite3*>(sqlite3_ptr_);
+  if (db == nullptr) {
+    // already closed
+    return false;
+  }
+  if (*stmt_ptr == nullptr) {
+    // kept for the lifetime of the connection
+    int ret = sqlite3_prepare_v3(db,
+                                 statement.c_str(),
+                                 static_cast<int>(statement.length()),
+                                 SQLITE_PREPARE_PERSISTENT,
+                                 reinterpret_cast<sqlite3_stmt**>(stmt_ptr),
+                                 nullptr);
+    if (ret != SQLITE_OK) {
+      std::ignore = std::fprintf(
+        stderr, "failed to prepare sqlite3 statement `%s`: %s\n", statement.c_str(), sqlite3_errmsg(db));
+      return false;
+    }
+  }
+  sqlite3_stmt* stmt = reinterpret_cast<sqlite3_stmt*>(*stmt_ptr);
+  int ret = sqlite3_step(stmt);
+  if (ret != SQLITE_DONE) {
+    std::ignore = std::fprintf(
+      stderr, "failed to execute sqlite3 statement `%s`: %s\n", statement.c_str(), sqlite3_errmsg(db));
+  }
+  sqlite3_reset(stmt);
+  return ret == SQLITE_DONE;
+}
+
+void DB::finalize_controls() {
+  for (void*& stmt : control_stmts_) {
+    sqlite3_finalize(reinterpret_cast<sqlite3_stmt*>(stmt));
+    stmt = nullptr;
+  }
+  for (std::array<void*, SAVEPOINT_CONTROL_COUNT>& stmts : savepoint_stmts_) {
+    for (void* stmt : stmts) {
+      sqlite3_finalize(reinterpret_cast<sqlite3_stmt*>(stmt));
+    }
+  }
+  savepoint_stmts_.clear();
+  savepoint_generations_.clear();
+}
+
+void DB::adopt_guards() {
+  for (Transaction* transaction : transaction_ptrs_) {
+    transaction->db_ptr_ = this;
+  }
+  for (Savepoint* savepoint : savepoint_ptrs_) {
+    savepoint->db_ptr_ = this;
+  }
+}
+
+void DB::detach_guards() {
+  // the connection is going away along with its transaction
+  for (Transaction* transaction : transaction_ptrs_) {
+    transaction->db_ptr_ = nullptr;
+  }
+  for (Savepoint* savepoint : savepoint_ptrs_) {
+    savepoint->db_ptr_ = nullptr;
+  }
+  transaction_ptrs_.clear();
+  savepoint_ptrs_.clear();
+}
+
+void DB::unmap() {
+  if (mmap_ptr_ != nullptr) {
+    ::munmap(mmap_ptr_, mmap_size_);
+  }
+  mmap_ptr_ = nullptr;
+  mmap_size_ = 0;
+}
+
 const char* sqlite_version() {
   return sqlite3_libversion();
 }
@@ -0,0 +1,148 @@
+#include "sqlitemm/row_batch.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <tuple>
+
+#include "sqlite3.h"
+
+#include "sqlitemm/value.hpp"
+
+namespace sqlitemm {
+
+// rows reserved up front by `RowBatch::reserve`, larger batches grow as they
+// fill and keep the capacity for the next batch
+constexpr std::size_t max_reserved_rows = 1024;
+
+[[nodiscard]] std::size_t RowBatch::size() const {
+  return column_count_ == 0 ? 0 : cells_.size() / static_cast<std::size_t>(column_count_);
+}
+
+[[nodiscard]] bool RowBatch::empty() const {
+  return cells_.empty();
+}
+
+[[nodiscard]] int RowBatch::column_count() const {
+  return column_count_;
+}
+
+[[nodiscard]] const RowBatch::Cell& RowBatch::cell(std::size_t row, int column) const {
+  return cells_[row * static_cast<std::size_t>(column_count_) + static_cast<std::size_t>(column)];
+}
+
+[[nodiscard]] Value::Type RowBatch::type(std::size_t row, int column) const {
+  return cell(row, column).type;
+}
+
+[[nodiscard]] Value::Integer RowBatch::integer(std::size_t row, int column) const {
+  return cell(row, column).integer;
+}
+
+[[nodiscard]] Value::Float RowBatch::real(std::size_t row, int column) const {
+  return cell(row, column).real;
+}
+
+[[nodiscard]] std::string_view RowBatch::text(std::size_t row, int column) const {
+  const Cell& c = cell(row, column);
+  return std::string_view{arena_}.substr(c.offset, c.bytes);
+}
+
+[[nodiscard]] const std::uint8_t* RowBatch::blob(std::size_t row, int column) const {
+  return reinterpret_cast<const std::uint8_t*>(arena_.data() + cell(row, column).offset);
+}
+
+[[nodiscard]] std::size_t RowBatch::bytes(std::size_t row, int column) const {
+  return cell(row, column).bytes;
+}
+
+[[nodiscard]] Value RowBatch::value(std::size_t row, int column) const {
+  const Cell& c = cell(row, column);
+  switch (c.type) {
+    case Value::Type::INTEGER: return Value{c.integer}; break;
+    case Value::Type::FLOAT: return Value{c.real}; break;
+    case Value::Type::TEXT: return Value{Value::Text{text(row, column)}}; break;
+    case Value::Type::BLOB: {
+      const std::uint8_t* blob_ptr = blob(row, column);
+      return Value{
+        Value::Blob{blob_ptr, blob_ptr + c.bytes}
+      };
+      break;
+    }
+    case Value::Type::NUL: return Value{Value::Null{nullptr}}; break;
+    default: break;
+  }
+  return Value{Value::Null{nullptr}};
+}
+
+void RowBatch::clear(int column_count) {
+  cells_.clear();
+  arena_.clear();
+  column_count_ = column_count;
+}
+
+void RowBatch::reserve(std::size_t rows) {
+  if (column_count_ <= 0) {
+    return;
+  }
+  const auto columns = static_cast<std::size_t>(column_count_);
+  rows = std::min({rows, max_reserved_rows, cells_.max_size() / columns});
+  cells_.reserve(rows * columns);
+}
+
+void RowBatch::append_row(void* stmt_ptr) {
+  sqlite3_stmt* stmt = reinterpret_cast<sqlite3_stmt*>(stmt_ptr);
+  for (int i = 0; i < column_count_; i++) {
+    Cell& c = cells_.emplace_back();
+    switch (sqlite3_column_type(stmt, i)) {
+      case SQLITE_INTEGER:
+        c.type = Value::Type::INTEGER;
+        c.integer = sqlite3_column_int64(stmt, i);
+        break;
+      case SQLITE_FLOAT:
+        c.type = Value::Type::FLOAT;
+        c.real = sqlite3_column_double(stmt, i);
+        break;
+      case SQLITE_TEXT: {
+        // `sqlite3_column_bytes` must follow the pointer conversion
+        const char* text_ptr = reinterpret_cast<const char*>(sqlite3_column_text(stmt, i));
+        c.type = Value::Type::TEXT;
+        c.offset = arena_.size();
+        c.bytes = static_cast<std::size_t>(sqlite3_column_bytes(stmt, i));
+        if (text_ptr == nullptr) {
+          // out of memory
+          c.bytes = 0;
+        }
+        if (c.bytes != 0) {
+          arena_.append(text_ptr, c.bytes);
+        }
+        break;
+      }
+      case SQLITE_BLOB: {
+        const char* blob_ptr = reinterpret_cast<const char*>(sqlite3_column_blob(stmt, i));
+        c.type = Value::Type::BLOB;
+        c.offset = arena_.size();
+        c.bytes = static_cast<std::size_t>(sqlite3_column_bytes(stmt, i));
+        if (blob_ptr == nullptr) {
+          // zero-length blob or out of memory
+          c.bytes = 0;
+        }
+        if (c.bytes != 0) {
+          arena_.append(blob_ptr, c.bytes);
+        }
+        break;
+      }
+      case SQLITE_NULL: c.type = Value::Type::NUL; break;
+      default:
+        // should not happen
+        std::ignore
+          = std::fprintf(stderr, "failed to get value from sqlite3_column, which should not happen. storing NULL.\n");
+        c.type = Value::Type::NUL;
+        break;
+    }
+  }
+}
+
+} // namespace sqlitemm
@@ -1,6 +1,8 @@
 #include "sqlitemm/stmt.hpp"
 
+#include <cstddef>
 #include <cstdio>
+#include <functional>
 #include <string>
 #include <string_view>
 #include <tuple>
@@ -10,6 +12,7 @@
 #include "sqlite3.h"
 
 #include "sqlitemm/db.hpp"
+#include "sqlitemm/row_batch.hpp"
 #include "sqlitemm/value.hpp"
 
 namespace sqlitemm {
@@ -203,6 +206,53 @@ Stmt& Stmt::each_row() {
   return *this;
 }
 
+Stmt& Stmt::each_batch(std::size_t batch_size, const std::function<void(const RowBatch&)>& callback) {
+  if (sqlite3_stmt_ptr_ == nullptr) {
+    // already closed
+    return *this;
+  }
+  if (batch_size == 0) {
+    std::ignore = std::fprintf(stderr, "failed to iterate batches: batch size must not be 0.\n");
+    return *this;
+  }
+  sqlite3_stmt* stmt = reinterpret_cast<sqlite3_stmt*>(sqlite3_stmt_ptr_);
+  int ret = sqlite3_step(stmt);
+  if (ret != SQLITE_DONE && ret != SQLITE_ROW) {
+    // failed to execute
+    char* sql = sqlite3_expanded_sql(stmt);
+    std::ignore = std::fprintf(stderr,
+                               "failed to execute sqlite3 statement `%s`: %s\n",
+                               sql == nullptr ? sqlite3_sql(stmt) : sql,
+                               sqlite3_errmsg(reinterpret_cast<sqlite3*>(db_ptr_->sqlite3_ptr_)));
+    sqlite3_free(sql);
+    return *this;
+  }
+  batch_.clear(sqlite3_column_count(stmt));
+  batch_.reserve(batch_size);
+  while (ret == SQLITE_ROW) {
+    batch_.append_row(stmt);
+    if (batch_.size() == batch_size) {
+      callback(batch_);
+      batch_.clear(batch_.column_count());
+    }
+    ret = sqlite3_step(stmt);
+  }
+  if (!batch_.empty()) {
+    callback(batch_);
+  }
+  if (ret != SQLITE_DONE) {
+    // failed to step
+    char* sql = sqlite3_expanded_sql(stmt);
+    std::ignore = std::fprintf(stderr,
+                               "failed to step sqlite3 statement `%s`: %s\n",
+                               sql == nullptr ? sqlite3_sql(stmt) : sql,
+                               sqlite3_errmsg(reinterpret_cast<sqlite3*>(db_ptr_->sqlite3_ptr_)));
+    sqlite3_free(sql);
+    return *this;
+  }
+  return *this;
+}
+
 [[nodiscard]] std::int64_t Stmt::changes() {
   return db_ptr_->changes();
 }
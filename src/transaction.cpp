@@ -0,0 +1,209 @@
+#include "sqlitemm/transaction.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <tuple>
+#include <vector>
+
+#include "sqlitemm/db.hpp"
+
+namespace sqlitemm {
+
+Transaction::Transaction(Transaction&& transaction_old) noexcept
+  : db_ptr_{transaction_old.db_ptr_}
+  , generation_{transaction_old.generation_} {
+  if (db_ptr_ != nullptr) {
+    db_ptr_->transaction_ptrs_.erase(&transaction_old);
+    db_ptr_->transaction_ptrs_.insert(this);
+  }
+  transaction_old.db_ptr_ = nullptr;
+}
+
+Transaction::~Transaction() {
+  if (db_ptr_ != nullptr) {
+    rollback();
+  }
+  detach();
+}
+
+bool Transaction::commit() {
+  if (!active()) {
+    std::ignore = std::fprintf(stderr, "failed to commit transaction: no transaction is active\n");
+    return false;
+  }
+  if (!db_ptr_->exec_control(DB::COMMIT)) {
+    // still open (e.g. SQLITE_BUSY) unless sqlite rolled it back
+    return false;
+  }
+  db_ptr_->savepoint_generations_.clear();
+  detach();
+  return true;
+}
+
+bool Transaction::rollback() {
+  if (db_ptr_ == nullptr) {
+    // never begun or already finished
+    return false;
+  }
+  if (!active()) {
+    // already ended outside this guard
+    return true;
+  }
+  if (!db_ptr_->exec_control(DB::ROLLBACK)) {
+    return false;
+  }
+  db_ptr_->savepoint_generations_.clear();
+  detach();
+  return true;
+}
+
+[[nodiscard]] bool Transaction::active() {
+  if (db_ptr_ == nullptr) {
+    return false;
+  }
+  if (db_ptr_->sqlite3_ptr_ == nullptr || generation_ != db_ptr_->transaction_generation_ || db_ptr_->autocommit()) {
+    // finished behind our back, e.g. by an error that rolls back, and maybe
+    // followed by another transaction
+    detach();
+    return false;
+  }
+  return true;
+}
+
+Transaction::Transaction(DB* db, DB::TransactionMode mode) : db_ptr_(db) {
+  if (db_ptr_->sqlite3_ptr_ == nullptr) {
+    std::ignore = std::fprintf(stderr, "failed to begin transaction: database is closed\n");
+    db_ptr_ = nullptr;
+    return;
+  }
+  if (!db_ptr_->autocommit()) {
+    std::ignore = std::fprintf(stderr, "failed to begin transaction: a transaction is already active\n");
+    db_ptr_ = nullptr;
+    return;
+  }
+  DB::Control control = DB::BEGIN_DEFERRED;
+  switch (mode) {
+    case DB::TransactionMode::DEFERRED: control = DB::BEGIN_DEFERRED; break;
+    case DB::TransactionMode::IMMEDIATE: control = DB::BEGIN_IMMEDIATE; break;
+    case DB::TransactionMode::EXCLUSIVE: control = DB::BEGIN_EXCLUSIVE; break;
+    default: break;
+  }
+  if (!db_ptr_->exec_control(control)) {
+    db_ptr_ = nullptr;
+    return;
+  }
+  generation_ = ++db_ptr_->generation_;
+  db_ptr_->transaction_generation_ = generation_;
+  db_ptr_->savepoint_generations_.clear();
+  db_ptr_->transaction_ptrs_.insert(this);
+}
+
+void Transaction::detach() {
+  if (db_ptr_ != nullptr) {
+    db_ptr_->transaction_ptrs_.erase(this);
+  }
+  db_ptr_ = nullptr;
+}
+
+Savepoint::Savepoint(Savepoint&& savepoint_old) noexcept
+  : db_ptr_{savepoint_old.db_ptr_}
+  , depth_{savepoint_old.depth_}
+  , generation_{savepoint_old.generation_} {
+  if (db_ptr_ != nullptr) {
+    db_ptr_->savepoint_ptrs_.erase(&savepoint_old);
+    db_ptr_->savepoint_ptrs_.insert(this);
+  }
+  savepoint_old.db_ptr_ = nullptr;
+}
+
+Savepoint::~Savepoint() {
+  if (db_ptr_ != nullptr) {
+    rollback();
+  }
+  detach();
+}
+
+bool Savepoint::release() {
+  if (!active()) {
+    std::ignore = std::fprintf(stderr, "failed to release savepoint: savepoint is not active\n");
+    return false;
+  }
+  if (!db_ptr_->exec_savepoint_control(depth_, DB::RELEASE)) {
+    return false;
+  }
+  // inner savepoints are released along with this one
+  db_ptr_->savepoint_generations_.resize(depth_);
+  detach();
+  return true;
+}
+
+bool Savepoint::rollback() {
+  if (!active()) {
+    return false;
+  }
+  if (!db_ptr_->exec_savepoint_control(depth_, DB::ROLLBACK_TO)) {
+    return false;
+  }
+  // `ROLLBACK TO` keeps the savepoint open
+  if (!db_ptr_->exec_savepoint_control(depth_, DB::RELEASE)) {
+    return false;
+  }
+  db_ptr_->savepoint_generations_.resize(depth_);
+  detach();
+  return true;
+}
+
+[[nodiscard]] bool Savepoint::active() {
+  if (db_ptr_ == nullptr) {
+    return false;
+  }
+  if (db_ptr_->sqlite3_ptr_ == nullptr) {
+    detach();
+    return false;
+  }
+  if (db_ptr_->autocommit()) {
+    // no savepoint survives the end of a transaction
+    db_ptr_->savepoint_generations_.clear();
+  }
+  const std::vector<std::uint64_t>& generations = db_ptr_->savepoint_generations_;
+  if (depth_ >= generations.size() || generations[depth_] != generation_) {
+    // released or rolled back along with an outer savepoint or transaction
+    detach();
+    return false;
+  }
+  return true;
+}
+
+Savepoint::Savepoint(DB* db) : db_ptr_(db) {
+  if (db_ptr_->sqlite3_ptr_ == nullptr) {
+    std::ignore = std::fprintf(stderr, "failed to open savepoint: database is closed\n");
+    db_ptr_ = nullptr;
+    return;
+  }
+  const bool begins_transaction = db_ptr_->autocommit();
+  if (begins_transaction) {
+    db_ptr_->savepoint_generations_.clear();
+  }
+  depth_ = db_ptr_->savepoint_generations_.size();
+  if (!db_ptr_->exec_savepoint_control(depth_, DB::SAVEPOINT)) {
+    db_ptr_ = nullptr;
+    return;
+  }
+  generation_ = ++db_ptr_->generation_;
+  if (begins_transaction) {
+    // outdates any `Transaction` left from an earlier transaction
+    db_ptr_->transaction_generation_ = generation_;
+  }
+  db_ptr_->savepoint_generations_.push_back(generation_);
+  db_ptr_->savepoint_ptrs_.insert(this);
+}
+
+void Savepoint::detach() {
+  if (db_ptr_ != nullptr) {
+    db_ptr_->savepoint_ptrs_.erase(this);
+  }
+  db_ptr_ = nullptr;
+}
+
+} // namespace sqlitemm
@@ -0,0 +1,39 @@
+#ifndef SQLITEMM_TEST_CHECK_HPP_
+#define SQLITEMM_TEST_CHECK_HPP_
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "sqlitemm/db.hpp"
+#include "sqlitemm/value.hpp"
+
+// helpers shared by the tests in this directory
+namespace test {
+
+inline int failures = 0;
+
+// report `what` if `ok` is false, the test fails at `result`
+inline void check(bool ok, const char* what) {
+  if (!ok) {
+    std::fprintf(stderr, "FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+// exit code of the test
+inline int result() {
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// number of rows in table `t`, -1 if it cannot be read
+inline sqlitemm::Value::Integer count(sqlitemm::DB& db) {
+  sqlitemm::Value::Integer n = -1;
+  db.exec("SELECT count(*) FROM t;",
+          [&n](const std::vector<sqlitemm::Value>& row) -> void { n = row[0].as<sqlitemm::Value::Integer>(); });
+  return n;
+}
+
+} // namespace test
+
+#endif // SQLITEMM_TEST_CHECK_HPP_
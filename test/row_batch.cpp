@@ -0,0 +1,75 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sqlitemm/db.hpp"
+#include "sqlitemm/row_batch.hpp"
+#include "sqlitemm/stmt.hpp"
+#include "sqlitemm/value.hpp"
+
+#include "check.hpp"
+
+namespace {
+
+// sizes of the batches `each_batch` hands over for `rows` rows
+std::vector<std::size_t> batch_sizes(std::size_t rows, std::size_t batch_size) {
+  sqlitemm::DB db;
+  db.exec("CREATE TABLE t(a INTEGER);");
+  for (std::size_t i = 0; i < rows; i++) {
+    db.exec("INSERT INTO t VALUES(" + std::to_string(i) + ");");
+  }
+  std::vector<std::size_t> sizes;
+  sqlitemm::Value::Integer next = 0;
+  bool ordered = true;
+  db.prepare("SELECT a FROM t ORDER BY a;")
+    .each_batch(batch_size, [&sizes, &next, &ordered](const sqlitemm::RowBatch& batch) -> void {
+    sizes.emplace_back(batch.size());
+    for (std::size_t row = 0; row < batch.size(); row++) {
+      ordered = ordered && batch.integer(row, 0) == next++;
+    }
+  });
+  test::check(ordered, "rows arrive in order across batches");
+  return sizes;
+}
+
+} // namespace
+
+int main() {
+  // batch boundaries
+  test::check(batch_sizes(0, 4).empty(), "no rows, no batch");
+  test::check(batch_sizes(3, 4) == std::vector<std::size_t>{3}, "n-1 rows make one short batch");
+  test::check(batch_sizes(4, 4) == std::vector<std::size_t>{4}, "n rows make one full batch");
+  test::check(batch_sizes(5, 4) == (std::vector<std::size_t>{4, 1}), "n+1 rows make a full and a short batch");
+  test::check(batch_sizes(5, SIZE_MAX) == std::vector<std::size_t>{5}, "SIZE_MAX takes all rows in one batch");
+
+  // cell types
+  sqlitemm::DB db;
+  db.exec("CREATE TABLE c(i, f, t, b);");
+  db.exec("INSERT INTO c VALUES(1, 0.5, 'text', x'010203');");
+  db.exec("INSERT INTO c VALUES(NULL, NULL, '', x'');");
+  sqlitemm::Stmt stmt = db.prepare("SELECT i, f, t, b FROM c ORDER BY rowid;");
+  for (int run = 0; run < 2; run++) {
+    int batches = 0;
+    stmt.each_batch(16, [&batches](const sqlitemm::RowBatch& batch) -> void {
+      batches++;
+      test::check(batch.size() == 2 && batch.column_count() == 4, "batch shape");
+      test::check(batch.type(0, 0) == sqlitemm::Value::Type::INTEGER && batch.integer(0, 0) == 1, "INTEGER cell");
+      test::check(batch.type(0, 1) == sqlitemm::Value::Type::FLOAT && batch.real(0, 1) == 0.5, "FLOAT cell");
+      test::check(batch.type(0, 2) == sqlitemm::Value::Type::TEXT && batch.text(0, 2) == "text", "TEXT cell");
+      test::check(
+        batch.type(0, 3) == sqlitemm::Value::Type::BLOB && batch.bytes(0, 3) == 3 && batch.blob(0, 3)[2] == 3,
+        "BLOB cell");
+      test::check(batch.type(1, 0) == sqlitemm::Value::Type::NUL && batch.type(1, 1) == sqlitemm::Value::Type::NUL,
+                  "NULL cells");
+      test::check(batch.type(1, 2) == sqlitemm::Value::Type::TEXT && batch.text(1, 2).empty(), "empty TEXT cell");
+      test::check(batch.type(1, 3) == sqlitemm::Value::Type::BLOB && batch.bytes(1, 3) == 0, "empty BLOB cell");
+      test::check(batch.value(0, 2).as<sqlitemm::Value::Text>() == "text", "TEXT cell copied into a Value");
+      test::check(batch.value(0, 3).as<sqlitemm::Value::Blob>() == sqlitemm::Value::Blob{1, 2, 3},
+                  "BLOB cell copied into a Value");
+    });
+    test::check(batches == 1, "re-run after reset gives the same batch");
+    stmt.reset();
+  }
+
+  return test::result();
+}
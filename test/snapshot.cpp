@@ -0,0 +1,97 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "sqlitemm/db.hpp"
+#include "sqlitemm/stmt.hpp"
+#include "sqlitemm/value.hpp"
+
+#include "check.hpp"
+
+namespace {
+
+void write_file(const std::filesystem::path& file, const sqlitemm::Value::Blob& image) {
+  std::ofstream out{file, std::ios::binary | std::ios::trunc};
+  out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+}
+
+} // namespace
+
+int main() {
+  const std::filesystem::path dir = std::filesystem::temp_directory_path();
+  const std::filesystem::path image_file = dir / "sqlitemm_test_snapshot.db";
+  const std::filesystem::path wal_file = dir / "sqlitemm_test_snapshot_wal.db";
+
+  sqlitemm::DB source;
+  test::check(sqlitemm::DB{}.serialize().empty(), "empty database serializes to an empty image");
+  source.exec("CREATE TABLE t(a INTEGER, b TEXT);");
+  for (int i = 0; i < 100; i++) {
+    source.prepare("INSERT INTO t VALUES(?, ?);")
+      .bind(1, sqlitemm::Value::of_integer(i))
+      .bind(2, sqlitemm::Value::of_text("row " + std::to_string(i)))
+      .each_row();
+  }
+  sqlitemm::Value::Blob image = source.serialize();
+  test::check(!image.empty(), "serialize returns an image");
+
+  // READONLY: used in place, writes fail
+  sqlitemm::DB readonly = sqlitemm::DB::deserialize(image);
+  test::check(test::count(readonly) == 100, "READONLY round trip keeps all rows");
+  readonly.exec("INSERT INTO t VALUES(100, 'row 100');");
+  test::check(test::count(readonly) == 100, "write to a READONLY database fails");
+  test::check(readonly.serialize() == image, "READONLY database serializes to the same image");
+
+  // RESIZEABLE: owns a copy, may grow
+  sqlitemm::DB resizeable = sqlitemm::DB::deserialize(image, sqlitemm::DB::DeserializeMode::RESIZEABLE);
+  for (int i = 100; i < 1000; i++) {
+    resizeable.exec("INSERT INTO t VALUES(" + std::to_string(i) + ", 'a longer row to grow the image');");
+  }
+  test::check(test::count(resizeable) == 1000, "RESIZEABLE database accepts writes");
+  test::check(resizeable.serialize().size() > image.size(), "RESIZEABLE database grows");
+
+  // a temporary image is kept by the DB
+  sqlitemm::DB owning = sqlitemm::DB::deserialize(source.serialize());
+  test::check(test::count(owning) == 100, "READONLY round trip over a temporary image keeps all rows");
+
+  // empty images give empty databases
+  sqlitemm::DB empty_readonly = sqlitemm::DB::deserialize(sqlitemm::DB{}.serialize());
+  test::check(empty_readonly.table_names().empty(), "empty READONLY image gives an empty database");
+  sqlitemm::DB empty_resizeable
+    = sqlitemm::DB::deserialize(sqlitemm::DB{}.serialize(), sqlitemm::DB::DeserializeMode::RESIZEABLE);
+  empty_resizeable.exec("CREATE TABLE t(a INTEGER);");
+  empty_resizeable.exec("INSERT INTO t VALUES(1);");
+  test::check(test::count(empty_resizeable) == 1, "empty RESIZEABLE image grows");
+  write_file(image_file, {});
+  sqlitemm::DB empty_file = sqlitemm::DB::deserialize(image_file, sqlitemm::DB::DeserializeMode::RESIZEABLE);
+  empty_file.exec("CREATE TABLE t(a INTEGER);");
+  test::check(test::count(empty_file) == 0, "empty image file gives an empty database");
+
+  // memory-mapped file
+  write_file(image_file, image);
+  sqlitemm::DB mapped = sqlitemm::DB::deserialize(image_file);
+  test::check(test::count(mapped) == 100, "mmap'd image keeps all rows");
+  // move assignment releases the previous mapping
+  mapped = sqlitemm::DB::deserialize(image_file);
+  test::check(test::count(mapped) == 100, "move-assigned mmap'd image keeps all rows");
+  sqlitemm::DB missing = sqlitemm::DB::deserialize(dir / "sqlitemm_test_missing.db");
+  test::check(test::count(missing) == -1, "missing image file gives a closed database");
+
+  // WAL-mode file: refused READONLY, readable RESIZEABLE
+  std::filesystem::remove(wal_file);
+  {
+    sqlitemm::DB wal{wal_file};
+    wal.exec("PRAGMA journal_mode = WAL;");
+    wal.exec("CREATE TABLE t(a INTEGER);");
+    wal.exec("INSERT INTO t VALUES(1);");
+    wal.exec("PRAGMA wal_checkpoint(TRUNCATE);");
+  }
+  sqlitemm::DB wal_readonly = sqlitemm::DB::deserialize(wal_file);
+  test::check(test::count(wal_readonly) == -1, "WAL image is refused in READONLY mode");
+  sqlitemm::DB wal_resizeable = sqlitemm::DB::deserialize(wal_file, sqlitemm::DB::DeserializeMode::RESIZEABLE);
+  test::check(test::count(wal_resizeable) == 1, "WAL image is readable in RESIZEABLE mode");
+
+  std::filesystem::remove(image_file);
+  std::filesystem::remove(wal_file);
+  return test::result();
+}
@@ -0,0 +1,112 @@
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "sqlitemm/db.hpp"
+#include "sqlitemm/stmt.hpp"
+#include "sqlitemm/transaction.hpp"
+#include "sqlitemm/value.hpp"
+
+#include "check.hpp"
+
+int main() {
+  sqlitemm::DB db;
+  db.exec("CREATE TABLE t(a INTEGER);");
+
+  // rollback on destruction, also when unwinding
+  {
+    sqlitemm::Transaction transaction = db.transaction();
+    test::check(transaction.active(), "transaction is active after BEGIN");
+    test::check(!db.autocommit(), "BEGIN leaves autocommit mode");
+    db.exec("INSERT INTO t VALUES(1);");
+  }
+  test::check(test::count(db) == 0, "destroyed transaction is rolled back");
+  test::check(db.autocommit(), "destroyed transaction ends");
+  try {
+    sqlitemm::Transaction transaction = db.transaction(sqlitemm::DB::TransactionMode::IMMEDIATE);
+    db.exec("INSERT INTO t VALUES(1);");
+    throw std::runtime_error{"unwind"};
+  } catch (const std::runtime_error&) {
+  }
+  test::check(test::count(db) == 0 && db.autocommit(), "exception rolls back the transaction");
+
+  // commit, refusing a second transaction
+  {
+    sqlitemm::Transaction transaction = db.transaction(sqlitemm::DB::TransactionMode::EXCLUSIVE);
+    db.exec("INSERT INTO t VALUES(1);");
+    sqlitemm::Transaction second = db.transaction();
+    test::check(!second.active(), "second transaction is refused");
+    test::check(transaction.commit(), "commit succeeds");
+    test::check(!transaction.active(), "committed transaction is not active");
+  }
+  test::check(test::count(db) == 1, "committed rows are kept");
+
+  // nested savepoints
+  {
+    sqlitemm::Transaction transaction = db.transaction();
+    db.exec("INSERT INTO t VALUES(2);");
+    {
+      sqlitemm::Savepoint outer = db.savepoint();
+      db.exec("INSERT INTO t VALUES(3);");
+      {
+        sqlitemm::Savepoint inner = db.savepoint();
+        db.exec("INSERT INTO t VALUES(4);");
+        test::check(inner.rollback(), "inner savepoint rolls back");
+      }
+      test::check(test::count(db) == 3, "inner rollback undoes only its rows");
+      sqlitemm::Savepoint inner = db.savepoint();
+      db.exec("INSERT INTO t VALUES(5);");
+      test::check(outer.release(), "outer savepoint releases");
+      test::check(!inner.active(), "inner savepoint is released along with the outer one");
+    }
+    {
+      sqlitemm::Savepoint dropped = db.savepoint();
+      db.exec("INSERT INTO t VALUES(6);");
+    }
+    test::check(transaction.commit(), "commit after savepoints succeeds");
+  }
+  test::check(test::count(db) == 4, "released savepoints are committed, dropped ones are not");
+
+  // guards outdated by a later transaction stay inactive
+  {
+    sqlitemm::Transaction transaction = db.transaction();
+    sqlitemm::Savepoint stale = db.savepoint();
+    test::check(transaction.commit(), "commit with an open savepoint succeeds");
+    sqlitemm::Transaction next = db.transaction();
+    sqlitemm::Savepoint current = db.savepoint();
+    db.exec("INSERT INTO t VALUES(7);");
+    test::check(!stale.rollback(), "stale savepoint does not roll back a later one");
+    test::check(current.release(), "later savepoint still releases");
+    test::check(next.commit(), "later transaction still commits");
+  }
+  test::check(test::count(db) == 5, "stale savepoint loses no data");
+  {
+    sqlitemm::Transaction stale = db.transaction();
+    db.exec("COMMIT;");
+    sqlitemm::Transaction next = db.transaction();
+    db.exec("INSERT INTO t VALUES(8);");
+    test::check(!stale.active(), "transaction ended outside its guard is not active");
+    test::check(next.commit(), "later transaction commits");
+  }
+  test::check(test::count(db) == 6, "stale transaction loses no data");
+
+  // guards outliving or following their DB
+  {
+    sqlitemm::DB closed;
+    sqlitemm::Transaction transaction = closed.transaction();
+    sqlitemm::Savepoint savepoint = closed.savepoint();
+    closed.close();
+    test::check(!transaction.active() && !savepoint.active(), "closing the DB detaches its guards");
+  }
+  {
+    sqlitemm::DB moved;
+    moved.exec("CREATE TABLE t(a INTEGER);");
+    sqlitemm::Transaction transaction = moved.transaction();
+    moved.exec("INSERT INTO t VALUES(1);");
+    sqlitemm::DB target = std::move(moved);
+    test::check(transaction.commit(), "guard follows the moved DB");
+    test::check(test::count(target) == 1, "moved DB keeps the committed row");
+  }
+
+  return test::result();
+}